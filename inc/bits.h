@@ -0,0 +1,129 @@
+#ifndef BITS_H
+#define BITS_H
+
+// Bit primitives. Portable constexpr versions, hardware versions compiled for
+// POPCNT/BMI/BMI2 targets and a table selected at runtime by CPU features.
+// Hot functions over whole boards are better multiversioned with BITS_DISPATCH,
+// so primitives stay inlined and each clone gets the instructions its CPU has.
+
+#include <cstdint>
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define BITS_X86 1
+#include <immintrin.h>
+#endif
+
+// Clones are resolved by ifunc before sanitizer runtimes are up, TSan crashes on it
+#if defined(__SANITIZE_THREAD__) || defined(__SANITIZE_ADDRESS__)
+#define BITS_SANITIZE 1
+#elif defined(__has_feature)
+#if __has_feature(thread_sanitizer) || __has_feature(address_sanitizer)
+#define BITS_SANITIZE 1
+#endif
+#endif
+
+#if defined(BITS_X86) && defined(__ELF__) && defined(__has_attribute) && !defined(BITS_SANITIZE)
+#if __has_attribute(target_clones) && (!defined(__clang__) || __clang_major__ >= 14)
+#define BITS_DISPATCH __attribute__((target_clones("arch=haswell", "popcnt", "default")))
+#endif
+#endif
+#ifndef BITS_DISPATCH
+#define BITS_DISPATCH
+#endif
+
+namespace bits {
+
+constexpr uint64_t DEBRUIJN = 0x03F79D71B4CB0A89ULL;
+
+constexpr int DEBRUIJN_INDEX[64] = {
+     0,  1, 48,  2, 57, 49, 28,  3, 61, 58, 50, 42, 38, 29, 17,  4,
+    62, 55, 59, 36, 53, 51, 43, 22, 45, 39, 33, 30, 24, 18, 12,  5,
+    63, 47, 56, 27, 60, 41, 37, 16, 54, 35, 52, 21, 44, 32, 23, 11,
+    46, 26, 40, 15, 34, 20, 31, 10, 25, 14, 19,  9, 13,  8,  7,  6,
+};
+
+constexpr int count_sw(uint64_t bb)
+{
+    bb = bb - ((bb >> 1) & 0x5555555555555555ULL);
+    bb = (bb & 0x3333333333333333ULL) + ((bb >> 2) & 0x3333333333333333ULL);
+    bb = (bb + (bb >> 4)) & 0x0F0F0F0F0F0F0F0FULL;
+    return int((bb * 0x0101010101010101ULL) >> 56);
+}
+
+constexpr int lsb_sw(uint64_t bb)
+{
+    return DEBRUIJN_INDEX[((bb & -bb) * DEBRUIJN) >> 58];
+}
+
+constexpr uint64_t bswap(uint64_t bb)
+{
+#if defined(__GNUC__) || defined(__clang__)
+    return __builtin_bswap64(bb);
+#else
+    bb = ((bb >> 8) & 0x00FF00FF00FF00FFULL) | ((bb & 0x00FF00FF00FF00FFULL) << 8);
+    bb = ((bb >> 16) & 0x0000FFFF0000FFFFULL) | ((bb & 0x0000FFFF0000FFFFULL) << 16);
+    return (bb >> 32) | (bb << 32);
+#endif
+}
+
+constexpr uint64_t pext_sw(uint64_t bb, uint64_t mask)
+{
+    uint64_t res = 0;
+    for (uint64_t bit = 1; mask; bit <<= 1, mask &= mask - 1)
+        if (bb & mask & -mask)
+            res |= bit;
+    return res;
+}
+
+#ifdef BITS_X86
+__attribute__((target("popcnt"))) inline int count_hw(uint64_t bb)              { return __builtin_popcountll(bb); }
+__attribute__((target("bmi")))    inline int lsb_hw(uint64_t bb)                { return int(_tzcnt_u64(bb)); }
+__attribute__((target("bmi2")))   inline uint64_t pext_hw(uint64_t bb, uint64_t m) { return _pext_u64(bb, m); }
+#endif
+
+struct Cpu {
+    bool popcnt = false;
+    bool bmi    = false;
+    bool bmi2   = false;
+};
+
+inline Cpu detect()
+{
+    Cpu cpu;
+#ifdef BITS_X86
+    __builtin_cpu_init();
+    cpu.popcnt  = __builtin_cpu_supports("popcnt");
+    cpu.bmi     = __builtin_cpu_supports("bmi");
+    cpu.bmi2    = __builtin_cpu_supports("bmi2");
+#endif
+    return cpu;
+}
+
+inline const Cpu CPU = detect();
+
+struct Ops {
+    int         (*count)(uint64_t);
+    int         (*lsb)(uint64_t);
+    uint64_t    (*pext)(uint64_t, uint64_t);
+};
+
+inline Ops select(const Cpu &cpu)
+{
+    Ops ops = { count_sw, lsb_sw, pext_sw };
+#ifdef BITS_X86
+    if (cpu.popcnt)
+        ops.count = count_hw;
+    if (cpu.bmi)
+        ops.lsb = lsb_hw;
+    if (cpu.bmi2)
+        ops.pext = pext_hw;
+#endif
+    return ops;
+}
+
+// Runtime selected primitives for code that can't be multiversioned
+inline const Ops OPS = select(CPU);
+
+} // bits
+
+#endif // BITS_H
@@ -1,35 +1,80 @@
 #ifndef ENGINE_H
 #define ENGINE_H
 
-#include "misc.h"
+#include "eval.h"
+#include <string>
 #include <vector>
 
 using MoveList  = std::vector<Move>;
 using Board     = std::vector<std::pair<Piece, Square>>;
 
+// What happens when man reaches last rank in the middle of capture
+enum Crowning {
+    CROWN_STOP,         // Crowned, capture ends
+    CROWN_CONTINUE,     // Crowned, capture continues as king
+    CROWN_PASS,         // Crowned only if capture ends there
+};
+
+struct Rules {
+    bool        flying_kings        = false;
+    bool        men_capture_back    = false;
+    bool        max_capture         = false;
+    Crowning    crowning            = CROWN_STOP;
+};
+
+constexpr Rules ENGLISH     = { false,  false,  false,  CROWN_STOP };
+constexpr Rules RUSSIAN     = { true,   true,   false,  CROWN_CONTINUE };
+constexpr Rules BRAZILIAN   = { true,   true,   true,   CROWN_PASS };
+constexpr Rules POOL        = { true,   true,   false,  CROWN_PASS };
+
+// Preset by its lower case name, false if there's no such preset
+bool rules_from(const std::string &name, Rules &r);
+
+// Captures are played hop by hop, turn doesn't change while the same piece must
+// continue. Captured pieces stay on the board until the whole capture is done.
 struct Engine {
 
-    void        reset();
+    void        reset(const Rules &r = ENGLISH);
     void        act(Move move);
 
     MoveList    legal_moves() const;
     Board       board() const;
 
+    bool        load(const std::string &fen);
+    std::string fen() const;
+
+    Features    features() const;
+    int         evaluate(const Weights &w) const;
+    int         evaluate() const;
+
+    uint64_t    hash() const;
+    bool        operator==(const Engine &rhs) const;
+
     Color       turn = BOTH;
 private:
     friend std::ostream& operator<<(std::ostream &os, const Engine &e);
 
+    static constexpr Square NONE = 64;
+
     bool        legal(Move move) const;
 
     Bitboard    all() const                    { return pieces[WHITE] | pieces[BLACK] | kings; }
     Bitboard    captures() const;
     Bitboard    man_moves(size_t sq) const     { return ATTACKS[turn][sq] & ~all(); }
-    Bitboard    king_moves(size_t sq) const    { return ATTACKS[BOTH][sq] & ~all(); }
-    Bitboard    man_capture_moves(size_t sq) const;
-    Bitboard    king_capture_moves(size_t sq) const;
+    Bitboard    king_moves(size_t sq) const    { return (rules.flying_kings ? slide(Square(sq), all()) : ATTACKS[BOTH][sq]) & ~all(); }
+    Bitboard    man_capture_moves(size_t sq) const     { return man_capture_moves(sq, pieces[~turn] & ~taken, all()); }
+    Bitboard    king_capture_moves(size_t sq) const    { return king_capture_moves(sq, pieces[~turn] & ~taken, all()); }
+    Bitboard    man_capture_moves(size_t sq, Bitboard opp, Bitboard occ) const;
+    Bitboard    king_capture_moves(size_t sq, Bitboard opp, Bitboard occ) const;
+    Bitboard    next_captures(Square from, Square to, bool king) const;
+    void        capture_move(MoveList &list, int &best, Square from, Square to, bool king) const;
+    int         longest(Square sq, bool king, Bitboard captured, Bitboard occ) const;
 
+    Rules       rules;
     Bitboard    pieces[BOTH] = {};
     Bitboard    kings = 0;
+    Bitboard    taken = 0;                     // Captured in current chain, not yet removed
+    Square      chain = NONE;                  // Piece which must continue capture
 };
 
 #endif // ENGINE_H
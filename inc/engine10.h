@@ -0,0 +1,73 @@
+#ifndef ENGINE10_H
+#define ENGINE10_H
+
+#include "engine.h"
+
+// International 10x10 draughts. 50 dark squares are packed 5 per row with a ghost
+// square after every even row, so diagonal steps are +-5 and +-6 bits everywhere
+// and anything shifted off the board lands on a ghost or outside of BOARD10_BB.
+//
+//  row 9:  50  51  52  53  54
+//  row 8:    44  45  46  47  48   (49)
+//  ...
+//  row 1:     6   7   8   9  10
+//  row 0:   0   1   2   3   4     (5)
+//
+// Squares in moves and board() are bit indices of this layout. Captures are played
+// hop by hop like in Engine: turn doesn't change while the capture must continue,
+// captured pieces stay on the board until the whole capture is done.
+
+constexpr size_t SQ10_NUM = 50;
+
+constexpr Bitboard BOARD10_BB   = 0x007DFFBFF7FEFFDFULL;
+constexpr Bitboard ROW10_0_BB   = 0x000000000000001FULL;
+constexpr Bitboard ROW10_9_BB   = 0x007C000000000000ULL;
+
+constexpr Bitboard PROMOTION10[] = { ROW10_9_BB, ROW10_0_BB };
+
+enum Direction10 {
+    NORTH_EAST10 =  6,
+    NORTH_WEST10 =  5,
+    SOUTH_EAST10 = -NORTH_WEST10,
+    SOUTH_WEST10 = -NORTH_EAST10,
+};
+
+constexpr Direction10 DIRECTIONS10[] = { NORTH_EAST10, NORTH_WEST10, SOUTH_EAST10, SOUTH_WEST10 };
+
+constexpr Square square10(int r, int f)             { return Square(r * 5 + f / 2 + (r + 1) / 2); }
+
+constexpr Bitboard shift(Bitboard b, Direction10 d)
+{
+    return (d > 0 ? b << d : b >> -d) & BOARD10_BB;
+}
+
+struct Engine10 {
+
+    void        reset();
+    void        act(Move move);
+
+    MoveList    legal_moves() const;
+    Board       board() const;
+
+    bool        operator==(const Engine10 &rhs) const;
+
+    Color       turn = BOTH;
+private:
+    friend std::ostream& operator<<(std::ostream &os, const Engine10 &e);
+
+    static constexpr Square NONE = 64;
+
+    template <class F>
+    void        hops(Square sq, bool king, Bitboard taken, Bitboard empty, F f) const;
+    int         longest(Square sq, bool king, Bitboard taken, Bitboard empty) const;
+    void        capture_moves(Square sq, MoveList &list, int &best) const;
+
+    Bitboard    all() const                     { return pieces[WHITE] | pieces[BLACK]; }
+
+    Bitboard    pieces[BOTH] = {};
+    Bitboard    kings = 0;
+    Bitboard    taken = 0;                      // Captured in current chain, not yet removed
+    Square      chain = NONE;                   // Piece which must continue capture
+};
+
+#endif // ENGINE10_H
@@ -0,0 +1,25 @@
+#ifndef EVAL_H
+#define EVAL_H
+
+#include "misc.h"
+
+// Linear evaluation terms, each weight is in centi-men
+enum EvalTerm {
+    EVAL_MAN,
+    EVAL_KING,
+    EVAL_PSQT,                      // Man placement, 32 dark squares relative to owner
+    EVAL_NUM = EVAL_PSQT + 32
+};
+
+// Men sum up to man count, so man on reference square a1 has no placement term.
+// Otherwise man value could move freely into placement and wouldn't be centi-men.
+constexpr int EVAL_PSQT_REF = EVAL_PSQT;
+
+using Weights   = std::array<int, EVAL_NUM>;
+using Features  = std::array<int8_t, EVAL_NUM>;  // White minus black term counts
+
+// Index of dark square among 32 playable ones, from white's point of view
+constexpr int dark_index(Square sq)                 { return sq >> 1; }
+constexpr int dark_index(Square sq, Color c)        { return dark_index(c == WHITE ? sq : Square(63 - sq)); }
+
+#endif // EVAL_H
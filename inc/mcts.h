@@ -0,0 +1,75 @@
+#ifndef MCTS_H
+#define MCTS_H
+
+#include "engine.h"
+#include <atomic>
+#include <memory>
+
+// Monte Carlo tree search player, strength is set by number of playouts.
+// Nodes live in a fixed arena, children of a node are one contiguous block.
+// Root is always expanded, arena has room at least for it and its children.
+// Threads share one tree, statistics are updated lock free and virtual loss
+// keeps threads from descending into the same path. Subtree of played move is
+// compacted into the spare arena and kept for next search.
+
+struct Mcts {
+
+    struct Stats {
+        uint64_t    playouts = 0;
+        double      seconds = 0;
+        size_t      nodes = 0;              // In use after last search or advance
+        size_t      node_bytes = 0;
+    };
+
+    Mcts(size_t max_nodes, size_t threads = 1);
+
+    void        reset(const Engine &e);
+    Move        search(uint64_t playouts);     // Null move (from == to) if root has no moves
+    bool        advance(Move move);             // False if move isn't legal in root
+
+    const Engine& position() const          { return root_pos; }
+    const Stats&  stats() const             { return last; }
+private:
+    static constexpr uint32_t NONE = UINT32_MAX;
+
+    enum State : uint8_t { LEAF, EXPANDING, EXPANDED };
+
+    struct Node {
+        Move                    move;
+        Color                   mover = BOTH;       // Side which played move, values are from its view
+        std::atomic<uint8_t>    state{LEAF};
+        uint16_t                count = 0;
+        uint32_t                first = NONE;
+        std::atomic<uint32_t>   visits{0};
+        std::atomic<uint32_t>   score{0};           // Half points: win 2, draw 1
+        std::atomic<uint32_t>   virtual_loss{0};
+    };
+
+    struct Arena {
+        Arena(size_t n) : capacity(n), nodes(new Node[n]) {}
+
+        uint32_t alloc(size_t n);
+
+        const size_t capacity;
+        std::unique_ptr<Node[]> nodes;
+        std::atomic<size_t> top{0};
+    };
+
+    static void init(Node &n, Move move, Color mover);
+
+    void        work(std::atomic<int64_t> &budget, uint64_t rng);
+    uint32_t    select(const Node &parent, uint64_t &rng) const;
+    bool        expand(Node &n, const Engine &e);
+    Color       playout(Engine e, uint64_t &rng) const;   // Winner, BOTH if drawn
+
+    Node&       node(uint32_t i)            { return arena->nodes[i]; }
+    const Node& node(uint32_t i) const      { return arena->nodes[i]; }
+
+    std::unique_ptr<Arena> arena;
+    std::unique_ptr<Arena> spare;
+    Engine      root_pos;
+    size_t      threads;
+    Stats       last;
+};
+
+#endif // MCTS_H
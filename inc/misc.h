@@ -1,6 +1,7 @@
 #ifndef TYPES_H
 #define TYPES_H
 
+#include "bits.h"
 #include <cstdint>
 #include <array>
 #include <string>
@@ -86,18 +87,30 @@ constexpr auto SQ_BB = generate_sq_bb();
 
 constexpr Square square(const int r, const int f)   { return (r << 3) + f; }
 constexpr bool valid(const Square sq)               { return sq < 64; }
+constexpr Square pdn_square(int n)                  { return square(7 - (n - 1) / 4, (n - 1) % 4 * 2 + ((7 - (n - 1) / 4) & 1)); }
+constexpr int pdn_number(Square sq)                 { return (7 - sq / 8) * 4 + (sq & 7) / 2 + 1; }
 constexpr Color operator~(Color c)                  { return Color(c ^ BLACK); }
 constexpr Bitboard bitboard(Square sq)              { return SQ_BB[sq]; }
 constexpr void set(Bitboard &bb, Square sq)         { bb |= bitboard(sq); }
 constexpr void clr(Bitboard &bb, Square sq)         { bb &= ~bitboard(sq); }
 constexpr bool get(Bitboard bb, Square sq)          { return bb & bitboard(sq); }
 
-#if __cplusplus > 201703L
+// Without POPCNT the builtins are a libgcc call, slower than SWAR count, which
+// compilers still turn into popcnt inside BITS_DISPATCH clones
+#if __cplusplus > 201703L && defined(__POPCNT__)
 constexpr int count(Bitboard bb)                    { return std::popcount(bb); }
+#elif (defined(__GNUC__) || defined(__clang__)) && defined(__POPCNT__)
+constexpr int count(Bitboard bb)                    { return __builtin_popcountll(bb); }
+#else
+constexpr int count(Bitboard bb)                    { return bits::count_sw(bb); }
+#endif
+
+#if __cplusplus > 201703L
 constexpr int lsb(Bitboard bb)                      { return std::countr_zero(bb);  }
+#elif defined(__GNUC__) || defined(__clang__)
+constexpr int lsb(Bitboard bb)                      { return __builtin_ctzll(bb);  }
 #else
-constexpr int count(Bitboard bb)                    { int cnt = 0; while (bb) { cnt++; bb &= bb - 1; } return cnt; }
-constexpr int lsb(Bitboard bb)                      { return count((bb & -bb) - 1);  }
+constexpr int lsb(Bitboard bb)                      { return bits::lsb_sw(bb);  }
 #endif
 
 constexpr Bitboard shift(Bitboard b, Direction d)
@@ -153,6 +166,43 @@ constexpr auto R_ATTACKS = generate_attacks(std::array{NORTH_EAST, SOUTH_EAST});
 constexpr auto L_ATTACKS = generate_attacks(std::array{NORTH_WEST, SOUTH_WEST});
 constexpr auto ATTACKS = generate_attacks(std::array{std::array{NORTH_EAST, NORTH_WEST}, std::array{SOUTH_EAST, SOUTH_WEST}});
 
+constexpr Direction DIAGONALS[] = { NORTH_EAST, NORTH_WEST, SOUTH_EAST, SOUTH_WEST }; // Opposite of i is 3 - i
+
+constexpr auto generate_rays()
+{
+    std::array<std::array<Bitboard, SQ_NUM>, 4> rays = {};
+
+    for (Square sq = 0; sq < SQ_NUM; ++sq)
+        for (size_t d = 0; d < 4; ++d)
+            for (auto bb = shift(bitboard(sq), DIAGONALS[d]); bb; bb = shift(bb, DIAGONALS[d]))
+                rays[d][sq] |= bb;
+
+    return rays;
+}
+constexpr auto RAYS = generate_rays();
+
+constexpr Bitboard line(Square sq, size_t d)        { return RAYS[d][sq] | RAYS[3 - d][sq]; }
+constexpr Bitboard between(Square a, Square b)
+{
+    return (RAYS[0][a] & RAYS[3][b]) | (RAYS[1][a] & RAYS[2][b]) |
+           (RAYS[2][a] & RAYS[1][b]) | (RAYS[3][a] & RAYS[0][b]);
+}
+
+// Hyperbola quintessence, squares reachable along a line up to and including first blocker
+constexpr Bitboard slide(Square sq, Bitboard occ, Bitboard mask)
+{
+    auto forward = occ & mask;
+    auto reverse = bits::bswap(forward);
+    forward -= bitboard(sq);
+    reverse -= bits::bswap(bitboard(sq));
+    return (forward ^ bits::bswap(reverse)) & mask;
+}
+
+constexpr Bitboard slide(Square sq, Bitboard occ)
+{
+    return slide(sq, occ, line(sq, 0)) | slide(sq, occ, line(sq, 1));
+}
+
 inline std::string to_str(Bitboard bb)
 {
     std::string str;
@@ -0,0 +1,110 @@
+#ifndef PROFILE_H
+#define PROFILE_H
+
+// Hot path instrumentation of Engine, compiled in only with ENGINE_PROFILE defined.
+// ENGINE_PROFILE_CYCLES additionally times every probe (inclusive of nested probes).
+// Counters are per-thread and summed only when collected.
+
+#include <cstdint>
+
+enum Probe {
+    PROBE_LEGAL_MOVES,          // items: moves generated
+    PROBE_CAPTURES,             // items: calls with any capture available
+    PROBE_MAN_CAPTURE_MOVES,    // items: calls with any capture move
+    PROBE_KING_CAPTURE_MOVES,   // items: calls with any capture move
+    PROBE_ACT,                  // items: capture chain continued
+    PROBE_NUM
+};
+
+#ifdef ENGINE_PROFILE
+
+#include <array>
+#include <atomic>
+#include <iosfwd>
+#if defined(ENGINE_PROFILE_CYCLES) && (defined(__x86_64__) || defined(__i386__))
+#include <x86intrin.h>
+#else
+#include <chrono>
+#endif
+
+namespace profile {
+
+#ifdef ENGINE_PROFILE_CYCLES
+constexpr bool TIMED = true;
+#else
+constexpr bool TIMED = false;
+#endif
+
+struct Counter {
+    uint64_t calls  = 0;
+    uint64_t items  = 0;
+    uint64_t cycles = 0;
+};
+
+using Report = std::array<Counter, PROBE_NUM>;
+
+Report  collect();
+void    reset();                // Only while no thread runs engine, owners' updates would overwrite it
+void    dump_json(std::ostream &os);
+void    dump_csv(std::ostream &os);
+
+const char* name(Probe p);
+
+// Written by owner thread only, so plain relaxed load and store instead of locked add
+struct Slot {
+    std::atomic<uint64_t> calls{0};
+    std::atomic<uint64_t> items{0};
+    std::atomic<uint64_t> cycles{0};
+};
+
+// Own cache lines, so blocks of neighbouring threads don't share one
+struct alignas(64) Block : std::array<Slot, PROBE_NUM> {};
+
+struct Handle {
+    Handle();
+    ~Handle();
+    Block *block;
+};
+inline thread_local Handle handle;
+
+inline void bump(std::atomic<uint64_t> &c, uint64_t n = 1)
+{
+    c.store(c.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+}
+
+inline uint64_t now()
+{
+#if !defined(ENGINE_PROFILE_CYCLES)
+    return 0;
+#elif defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    return std::chrono::steady_clock::now().time_since_epoch().count();
+#endif
+}
+
+struct Scope {
+    Scope(Probe p) : slot((*handle.block)[p]), start(now()) { bump(slot.calls); }
+#ifdef ENGINE_PROFILE_CYCLES
+    ~Scope() { bump(slot.cycles, now() - start); }
+#endif
+private:
+    Slot &slot;
+    uint64_t start;
+};
+
+inline void add(Probe p, uint64_t n) { bump((*handle.block)[p].items, n); }
+
+} // profile
+
+#define PROFILE_SCOPE(probe)    profile::Scope profile_scope_(probe)
+#define PROFILE_ADD(probe, n)   profile::add(probe, n)
+
+#else
+
+#define PROFILE_SCOPE(probe)
+#define PROFILE_ADD(probe, n)
+
+#endif // ENGINE_PROFILE
+
+#endif // PROFILE_H
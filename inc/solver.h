@@ -0,0 +1,28 @@
+#ifndef SOLVER_H
+#define SOLVER_H
+
+#include "engine.h"
+
+// Exact solver based on depth-first proof-number search. Proves win of either side,
+// repeated positions count as not won, so draws are reported as unproven.
+// Table of proof and disproof numbers has fixed size, entries with least work done
+// under them are collected when it fills up. Threads share the table and spread
+// over the tree by adding virtual proof numbers to nodes being searched.
+
+enum Proof {
+    UNPROVEN,
+    PROVEN_WIN,
+    PROVEN_LOSS,
+};
+
+struct Solution {
+    Proof       result = UNPROVEN;      // For side to move
+    MoveList    line;                   // Main line of proof, winner plays best defence
+    uint64_t    nodes = 0;
+    double      seconds = 0;
+    size_t      peak_memory = 0;        // Bytes of table entries in use at most
+};
+
+Solution solve(const Engine &e, uint64_t nodes, size_t memory, size_t threads = 1);
+
+#endif // SOLVER_H
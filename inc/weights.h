@@ -0,0 +1,20 @@
+#ifndef WEIGHTS_H
+#define WEIGHTS_H
+
+#include "eval.h"
+
+// Generated by tools/tune, do not edit by hand
+
+constexpr Weights WEIGHTS = {
+    100, 300,
+      0,   0,   0,   0,
+      0,   0,   0,   0,
+      0,   0,   0,   0,
+      0,   0,   0,   0,
+      0,   0,   0,   0,
+      0,   0,   0,   0,
+      0,   0,   0,   0,
+      0,   0,   0,   0,
+};
+
+#endif // WEIGHTS_H
@@ -1,51 +1,82 @@
 #include "engine.h"
+#include "weights.h"
+#include "profile.h"
+#include <algorithm>
+#include <cctype>
 #include <cstddef>
 #include <ostream>
 
-void Engine::reset()
+bool rules_from(const std::string &name, Rules &r)
+{
+    if (name == "english")
+        r = ENGLISH;
+    else if (name == "russian")
+        r = RUSSIAN;
+    else if (name == "brazilian")
+        r = BRAZILIAN;
+    else if (name == "pool")
+        r = POOL;
+    else
+        return false;
+    return true;
+}
+
+void Engine::reset(const Rules &r)
 {
     pieces[WHITE] = 0x00000000'0055AA55;
     pieces[BLACK] = 0xAA55AA00'00000000;
     kings = 0x00000000'00000000;
+    taken = 0;
+    chain = NONE;
+    rules = r;
 
     turn = WHITE;
 }
 
 void Engine::act(Move move)
 {
+    PROFILE_SCOPE(PROBE_ACT);
+
     const auto f_bb = bitboard(move.from);
     const auto t_bb = bitboard(move.to);
+    const auto last = t_bb & OPPOSITE_RANK[turn];
 
-    pieces[turn]    |= t_bb;
-    if (kings & f_bb || move.type & PROMOTION)
-        kings       |= t_bb;
+    bool king = kings & f_bb;
 
-    pieces[turn]    &= ~f_bb;
+    pieces[turn]    ^= f_bb | t_bb;
     kings           &= ~f_bb;
 
-    if (move.type & CAPTURE) {
-        switch (int(move.to) - int(move.from)) {
-            case NORTH_EAST * 2:
-                pieces[~turn]   &= ~(f_bb << NORTH_EAST);
-                kings           &= ~(f_bb << NORTH_EAST);
-                break;
-            case NORTH_WEST * 2:
-                pieces[~turn]   &= ~(f_bb << NORTH_WEST);
-                kings           &= ~(f_bb << NORTH_WEST);
-                break;
-            case SOUTH_EAST * 2:
-                pieces[~turn]   &= ~(t_bb << NORTH_WEST);
-                kings           &= ~(t_bb << NORTH_WEST);
-                break;
-            case SOUTH_WEST * 2:
-                pieces[~turn]   &= ~(t_bb << NORTH_EAST);
-                kings           &= ~(t_bb << NORTH_EAST);
-                break;
-        }
-        // If another move available with same piece
-        if (man_capture_moves(move.to) || king_capture_moves(move.to))
-            return;
+    if (!(move.type & CAPTURE)) {
+        if (king || last)
+            kings |= t_bb;
+        turn = ~turn;
+        return;
     }
+    taken |= between(move.from, move.to) & pieces[~turn];
+
+    const bool crowned = !king && last;
+
+    if (crowned && rules.crowning != CROWN_PASS)
+        king = true;
+    if (king)
+        kings |= t_bb;
+
+    // If another capture available with same piece
+    if (!(crowned && rules.crowning == CROWN_STOP) &&
+        (king ? king_capture_moves(move.to) : man_capture_moves(move.to)))
+    {
+        PROFILE_ADD(PROBE_ACT, 1);
+        chain = move.to;
+        return;
+    }
+    if (crowned)
+        kings |= t_bb;
+
+    pieces[~turn]   &= ~taken;
+    kings           &= ~taken;
+    taken = 0;
+    chain = NONE;
+
     turn = ~turn;
 }
 
@@ -59,62 +90,173 @@ bool Engine::legal(Move move) const
 
 Bitboard Engine::captures() const
 {
+    PROFILE_SCOPE(PROBE_CAPTURES);
+
     const auto non = ~all();
-    const auto opp = pieces[~turn];
-    const auto k = pieces[turn] & kings;
+    const auto opp = pieces[~turn] & ~taken;
+    const auto men = pieces[turn] & ~kings;
+    const auto k = rules.flying_kings ? 0 : pieces[turn] & kings;
+    const auto back = rules.men_capture_back ? men : 0;
 
-    auto captures = (shift(shift(k, NORTH_EAST) & opp, NORTH_EAST) & non) |
-                    (shift(shift(k, NORTH_WEST) & opp, NORTH_WEST) & non) |
-                    (shift(shift(k, SOUTH_EAST) & opp, SOUTH_EAST) & non) |
-                    (shift(shift(k, SOUTH_WEST) & opp, SOUTH_WEST) & non);
+    const auto north = k | back | (turn == WHITE ? men : 0);
+    const auto south = k | back | (turn == BLACK ? men : 0);
+
+    auto captures = (shift(shift(north, NORTH_EAST) & opp, NORTH_EAST) & non) |
+                    (shift(shift(north, NORTH_WEST) & opp, NORTH_WEST) & non) |
+                    (shift(shift(south, SOUTH_EAST) & opp, SOUTH_EAST) & non) |
+                    (shift(shift(south, SOUTH_WEST) & opp, SOUTH_WEST) & non);
+
+    if (rules.flying_kings)
+        for (const auto sq : BitIterator(pieces[turn] & kings))
+            captures |= king_capture_moves(sq);
+
+    PROFILE_ADD(PROBE_CAPTURES, captures != 0);
 
-    if (turn == WHITE) {
-        captures |= (shift(shift(pieces[WHITE], NORTH_EAST) & opp, NORTH_EAST) & non) |
-                    (shift(shift(pieces[WHITE], NORTH_WEST) & opp, NORTH_WEST) & non);
-    } else {
-        captures |= (shift(shift(pieces[BLACK], SOUTH_EAST) & opp, SOUTH_EAST) & non) |
-                    (shift(shift(pieces[BLACK], SOUTH_WEST) & opp, SOUTH_WEST) & non);
-    }
     return captures;
 }
 
-Bitboard Engine::man_capture_moves(size_t sq) const
+Bitboard Engine::man_capture_moves(size_t sq, Bitboard opp, Bitboard occ) const
 {
-    const auto non = ~all();
+    PROFILE_SCOPE(PROBE_MAN_CAPTURE_MOVES);
+
+    const auto non = ~occ;
+    Bitboard moves = 0;
+
+    if (turn == WHITE || rules.men_capture_back) {
+        moves |= (shift(R_ATTACKS[WHITE][sq] & opp, NORTH_EAST) & non) |
+                 (shift(L_ATTACKS[WHITE][sq] & opp, NORTH_WEST) & non);
+    }
+    if (turn == BLACK || rules.men_capture_back) {
+        moves |= (shift(R_ATTACKS[BLACK][sq] & opp, SOUTH_EAST) & non) |
+                 (shift(L_ATTACKS[BLACK][sq] & opp, SOUTH_WEST) & non);
+    }
+    PROFILE_ADD(PROBE_MAN_CAPTURE_MOVES, moves != 0);
+
+    return moves;
+}
 
-    if (turn == WHITE) {
-        return (shift(R_ATTACKS[WHITE][sq] & pieces[BLACK], NORTH_EAST) & non) |
-               (shift(L_ATTACKS[WHITE][sq] & pieces[BLACK], NORTH_WEST) & non);
+Bitboard Engine::king_capture_moves(size_t sq, Bitboard opp, Bitboard occ) const
+{
+    PROFILE_SCOPE(PROBE_KING_CAPTURE_MOVES);
+
+    const auto non = ~occ;
+    Bitboard moves = 0;
+
+    if (rules.flying_kings) {
+        // First piece met on each ray, if it's opponent's land anywhere behind it up to next piece
+        const auto attacks = slide(Square(sq), occ);
+        for (size_t d = 0; d < 4; ++d) {
+            const auto target = attacks & RAYS[d][sq] & opp;
+            if (target) {
+                const auto t = Square(lsb(target));
+                moves |= slide(t, occ, line(t, d)) & RAYS[d][t] & non;
+            }
+        }
     } else {
-        return (shift(R_ATTACKS[BLACK][sq] & pieces[WHITE], SOUTH_EAST) & non) |
-               (shift(L_ATTACKS[BLACK][sq] & pieces[WHITE], SOUTH_WEST) & non);
+        moves = (shift(R_ATTACKS[WHITE][sq] & opp, NORTH_EAST) & non) |
+                (shift(L_ATTACKS[WHITE][sq] & opp, NORTH_WEST) & non) |
+                (shift(R_ATTACKS[BLACK][sq] & opp, SOUTH_EAST) & non) |
+                (shift(L_ATTACKS[BLACK][sq] & opp, SOUTH_WEST) & non);
     }
+    PROFILE_ADD(PROBE_KING_CAPTURE_MOVES, moves != 0);
+
+    return moves;
 }
 
-Bitboard Engine::king_capture_moves(size_t sq) const
+// Number of captures the piece can still make in a row, for maximum capture rule
+int Engine::longest(Square sq, bool king, Bitboard captured, Bitboard occ) const
 {
-    const auto non = ~all();
-    const auto opp = pieces[~turn];
+    const auto opp = pieces[~turn] & ~captured;
+    const auto moves = king ? king_capture_moves(sq, opp, occ) : man_capture_moves(sq, opp, occ);
+
+    int best = 0;
+
+    for (const auto to : BitIterator(moves)) {
+
+        const bool crowned = !king && bitboard(to) & OPPOSITE_RANK[turn];
+        int n = 1;
+
+        if (!crowned || rules.crowning != CROWN_STOP) {
+            n += longest(Square(to), king || (crowned && rules.crowning == CROWN_CONTINUE),
+                    captured | (between(sq, to) & opp), (occ & ~bitboard(sq)) | bitboard(to));
+        }
+        best = std::max(best, n);
+    }
+    return best;
+}
 
-    return (shift(R_ATTACKS[WHITE][sq] & opp, NORTH_EAST) & non) |
-           (shift(L_ATTACKS[WHITE][sq] & opp, NORTH_WEST) & non) |
-           (shift(R_ATTACKS[BLACK][sq] & opp, SOUTH_EAST) & non) |
-           (shift(L_ATTACKS[BLACK][sq] & opp, SOUTH_WEST) & non);
+Bitboard Engine::next_captures(Square from, Square to, bool king) const
+{
+    const auto opp = pieces[~turn] & ~taken & ~between(from, to);
+    const auto occ = (all() & ~bitboard(from)) | bitboard(to);
+
+    return king ? king_capture_moves(to, opp, occ) : man_capture_moves(to, opp, occ);
+}
+
+void Engine::capture_move(MoveList &list, int &best, Square from, Square to, bool king) const
+{
+    uint8_t type = CAPTURE;
+
+    const bool crowned = !king && bitboard(to) & OPPOSITE_RANK[turn];
+
+    if (crowned && (rules.crowning != CROWN_PASS || !next_captures(from, to, false)))
+        type |= PROMOTION;
+
+    if (rules.max_capture) {
+        const auto captured = taken | (between(from, to) & pieces[~turn]);
+        const auto occ = (all() & ~bitboard(from)) | bitboard(to);
+        int n = 1;
+        if (!crowned || rules.crowning != CROWN_STOP)
+            n += longest(to, king || (crowned && rules.crowning == CROWN_CONTINUE), captured, occ);
+        if (n < best)
+            return;
+        if (n > best) {
+            best = n;
+            list.clear();
+        }
+    }
+    list.emplace_back(from, to, type);
 }
 
+BITS_DISPATCH
 MoveList Engine::legal_moves() const
 {
+    PROFILE_SCOPE(PROBE_LEGAL_MOVES);
+
     MoveList list;
 
-    if (captures()) {
+    if (chain != NONE || captures()) {
+
+        const auto own = chain != NONE ? bitboard(chain) : pieces[turn];
+        int best = 0;
+
+        for (const auto from : BitIterator(own & kings)) {
 
-        for (const auto from : BitIterator(pieces[turn] & kings))
-             for (const auto to : BitIterator(king_capture_moves(from)))
-                 list.emplace_back(Square(from), Square(to), CAPTURE);
+            const auto moves = king_capture_moves(from);
 
-        for (const auto from : BitIterator(pieces[turn] & ~kings))
+            for (size_t d = 0; d < 4; ++d) {
+
+                auto lands = moves & RAYS[d][from];
+
+                // Flying king must land where capture goes on, if there is such square
+                if (rules.flying_kings && !rules.max_capture) {
+                    Bitboard next = 0;
+                    for (const auto to : BitIterator(lands))
+                        if (next_captures(Square(from), Square(to), true))
+                            set(next, to);
+                    if (next)
+                        lands = next;
+                }
+                for (const auto to : BitIterator(lands))
+                    capture_move(list, best, Square(from), Square(to), true);
+            }
+        }
+
+        for (const auto from : BitIterator(own & ~kings))
             for (const auto to : BitIterator(man_capture_moves(from)))
-                list.emplace_back(Square(from), Square(to), bitboard(to) & OPPOSITE_RANK[turn] ? PROMOTION | CAPTURE : CAPTURE);
+                capture_move(list, best, Square(from), Square(to), false);
+
+        PROFILE_ADD(PROBE_LEGAL_MOVES, list.size());
 
         return list;
     }
@@ -127,9 +269,12 @@ MoveList Engine::legal_moves() const
         for (const auto to : BitIterator(man_moves(from)))
             list.emplace_back(Square(from), Square(to), bitboard(to) & OPPOSITE_RANK[turn] ? PROMOTION : QUIET);
 
+    PROFILE_ADD(PROBE_LEGAL_MOVES, list.size());
+
     return list;
 }
 
+BITS_DISPATCH
 Board Engine::board() const
 {
     Board board;
@@ -149,6 +294,150 @@ Board Engine::board() const
     return board;
 }
 
+// PDN FEN with engine colors, e.g. "W:W21-32:B1-12,K15". White plays up from 21-32.
+bool Engine::load(const std::string &fen)
+{
+    Bitboard p[BOTH] = {};
+    Bitboard k = 0;
+    Color t;
+
+    auto c = fen.c_str();
+
+    if (*c == 'W')
+        t = WHITE;
+    else if (*c == 'B')
+        t = BLACK;
+    else
+        return false;
+    ++c;
+
+    auto number = [&c]() {
+        int n = 0;
+        if (!isdigit(*c))
+            return -1;
+        while (isdigit(*c))
+            n = n * 10 + *c++ - '0';
+        return n;
+    };
+
+    while (*c == ':') {
+
+        const auto side = *++c == 'W' ? WHITE : *c == 'B' ? BLACK : BOTH;
+        if (side == BOTH)
+            return false;
+        ++c;
+
+        while (*c && *c != ':' && *c != '.') {
+
+            const bool king = *c == 'K';
+            c += king;
+
+            const int lo = number();
+            const int hi = *c == '-' ? (++c, number()) : lo;
+
+            if (lo < 1 || hi > 32 || lo > hi)
+                return false;
+
+            for (int n = lo; n <= hi; ++n) {
+                set(p[side], pdn_square(n));
+                if (king)
+                    set(k, pdn_square(n));
+            }
+            if (*c == ',')
+                ++c;
+        }
+    }
+    if ((*c && *c != '.') || (p[WHITE] & p[BLACK]))
+        return false;
+
+    pieces[WHITE] = p[WHITE];
+    pieces[BLACK] = p[BLACK];
+    kings = k;
+    taken = 0;
+    chain = NONE;
+    turn = t;
+
+    return true;
+}
+
+std::string Engine::fen() const
+{
+    std::string str = turn == BLACK ? "B" : "W";
+
+    for (const auto c : { WHITE, BLACK }) {
+        str += c == WHITE ? ":W" : ":B";
+        bool first = true;
+        for (int n = 1; n <= 32; ++n) {
+            const auto sq = pdn_square(n);
+            if (!get(pieces[c], sq))
+                continue;
+            if (!first)
+                str += ',';
+            if (get(kings, sq))
+                str += 'K';
+            str += std::to_string(n);
+            first = false;
+        }
+    }
+    return str;
+}
+
+BITS_DISPATCH
+Features Engine::features() const
+{
+    Features f = {};
+
+    f[EVAL_MAN]  = count(pieces[WHITE] & ~kings) - count(pieces[BLACK] & ~kings);
+    f[EVAL_KING] = count(pieces[WHITE] & kings) - count(pieces[BLACK] & kings);
+
+    for (const auto sq : BitIterator(pieces[WHITE] & ~kings))
+        ++f[EVAL_PSQT + dark_index(sq, WHITE)];
+
+    for (const auto sq : BitIterator(pieces[BLACK] & ~kings))
+        --f[EVAL_PSQT + dark_index(sq, BLACK)];
+
+    f[EVAL_PSQT_REF] = 0;
+
+    return f;
+}
+
+int Engine::evaluate(const Weights &w) const
+{
+    const auto f = features();
+
+    int score = 0;
+    for (size_t i = 0; i < EVAL_NUM; ++i)
+        score += f[i] * w[i];
+
+    return turn == WHITE ? score : -score;
+}
+
+int Engine::evaluate() const
+{
+    return evaluate(WEIGHTS);
+}
+
+uint64_t Engine::hash() const
+{
+    auto mix = [](uint64_t x) {
+        x ^= x >> 33;
+        x *= 0xFF51AFD7ED558CCDULL;
+        x ^= x >> 33;
+        x *= 0xC4CEB9FE1A85EC53ULL;
+        return x ^ (x >> 33);
+    };
+    return mix(pieces[WHITE] ^ mix(pieces[BLACK] ^ mix(kings ^ mix(taken ^ (uint64_t(chain) << 1 | turn)))));
+}
+
+bool Engine::operator==(const Engine &rhs) const
+{
+    return  pieces[WHITE] == rhs.pieces[WHITE] &&
+            pieces[BLACK] == rhs.pieces[BLACK] &&
+            kings == rhs.kings &&
+            taken == rhs.taken &&
+            chain == rhs.chain &&
+            turn == rhs.turn;
+}
 
 std::ostream& operator<<(std::ostream &os, const Engine &e)
 {
@@ -0,0 +1,212 @@
+#include "engine10.h"
+#include <algorithm>
+#include <cctype>
+#include <ostream>
+
+void Engine10::reset()
+{
+    pieces[WHITE] = 0x00000000'003EFFDF;
+    pieces[BLACK] = 0x007DFFBE'00000000;
+    kings = 0;
+    taken = 0;
+    chain = NONE;
+
+    turn = WHITE;
+}
+
+void Engine10::act(Move move)
+{
+    const auto f_bb = bitboard(move.from);
+    const auto t_bb = bitboard(move.to);
+    const bool king = kings & f_bb;
+
+    pieces[turn] ^= f_bb | t_bb;
+    if (king)
+        kings ^= f_bb | t_bb;
+
+    if (move.type & CAPTURE) {
+
+        for (const auto d : DIRECTIONS10) {
+            Bitboard ray = 0;
+            auto bb = shift(f_bb, d);
+            for (; bb && !(bb & t_bb); bb = shift(bb, d))
+                ray |= bb;
+            if (bb) {
+                taken |= ray & pieces[~turn];
+                break;
+            }
+        }
+        // Maximum capture rule, piece must go on while longer capture exists
+        if (longest(move.to, king, taken, BOARD10_BB & ~all())) {
+            chain = move.to;
+            return;
+        }
+        pieces[~turn]   &= ~taken;
+        kings           &= ~taken;
+        taken = 0;
+        chain = NONE;
+    }
+    // Man passing promotion row during capture isn't promoted
+    if (!king && t_bb & PROMOTION10[turn])
+        kings |= t_bb;
+
+    turn = ~turn;
+}
+
+template <class F>
+void Engine10::hops(Square sq, bool king, Bitboard captured, Bitboard empty, F f) const
+{
+    const auto opp = pieces[~turn] & ~captured;
+    const auto bb = bitboard(sq);
+
+    for (const auto d : DIRECTIONS10) {
+        if (king) {
+            auto over = shift(bb, d);
+            while (over & empty)
+                over = shift(over, d);
+            if (!(over & opp))
+                continue;
+            for (auto to = shift(over, d) & empty; to; to = shift(to, d) & empty)
+                f(Square(lsb(to)), Square(lsb(over)));
+        } else {
+            const auto over = shift(bb, d) & opp;
+            const auto to = shift(over, d) & empty;
+            if (to)
+                f(Square(lsb(to)), Square(lsb(over)));
+        }
+    }
+}
+
+int Engine10::longest(Square sq, bool king, Bitboard captured, Bitboard empty) const
+{
+    int best = 0;
+
+    hops(sq, king, captured, empty, [&](Square to, Square over) {
+        const auto next_empty = (empty | bitboard(sq)) & ~bitboard(to);
+        best = std::max(best, 1 + longest(to, king, captured | bitboard(over), next_empty));
+    });
+    return best;
+}
+
+void Engine10::capture_moves(Square sq, MoveList &list, int &best) const
+{
+    const bool king = kings & bitboard(sq);
+    const auto empty = BOARD10_BB & ~all();
+
+    hops(sq, king, taken, empty, [&](Square to, Square over) {
+
+        const auto rest = longest(to, king, taken | bitboard(over), (empty | bitboard(sq)) & ~bitboard(to));
+
+        if (rest + 1 < best)
+            return;
+        if (rest + 1 > best) {
+            best = rest + 1;
+            list.clear();
+        }
+        const bool promotion = !king && !rest && bitboard(to) & PROMOTION10[turn];
+        list.emplace_back(sq, to, promotion ? PROMOTION | CAPTURE : CAPTURE);
+    });
+}
+
+MoveList Engine10::legal_moves() const
+{
+    MoveList list;
+    int best = 0;
+
+    if (chain != NONE) {
+        capture_moves(chain, list, best);
+        return list;
+    }
+
+    for (const auto from : BitIterator(pieces[turn]))
+        capture_moves(Square(from), list, best);
+
+    if (best)
+        return list;
+
+    const auto empty = BOARD10_BB & ~all();
+
+    for (const auto from : BitIterator(pieces[turn] & kings))
+        for (const auto d : DIRECTIONS10)
+            for (auto to = shift(bitboard(from), d) & empty; to; to = shift(to, d) & empty)
+                list.emplace_back(Square(from), Square(lsb(to)), QUIET);
+
+    const Direction10 forward[BOTH][2] = {
+        { NORTH_EAST10, NORTH_WEST10 },
+        { SOUTH_EAST10, SOUTH_WEST10 },
+    };
+
+    for (const auto from : BitIterator(pieces[turn] & ~kings))
+        for (const auto d : forward[turn])
+            for (const auto to : BitIterator(shift(bitboard(from), d) & empty))
+                list.emplace_back(Square(from), Square(to), bitboard(to) & PROMOTION10[turn] ? PROMOTION : QUIET);
+
+    return list;
+}
+
+Board Engine10::board() const
+{
+    Board board;
+
+    for (const auto sq : BitIterator(pieces[WHITE] & ~kings))
+        board.push_back( {{ MAN, WHITE }, Square(sq)} );
+
+    for (const auto sq : BitIterator(pieces[WHITE] & kings))
+        board.push_back( {{ KING, WHITE }, Square(sq)} );
+
+    for (const auto sq : BitIterator(pieces[BLACK] & ~kings))
+        board.push_back( {{ MAN, BLACK }, Square(sq)} );
+
+    for (const auto sq : BitIterator(pieces[BLACK] & kings))
+        board.push_back( {{ KING, BLACK }, Square(sq)} );
+
+    return board;
+}
+
+bool Engine10::operator==(const Engine10 &rhs) const
+{
+    return  pieces[WHITE] == rhs.pieces[WHITE] &&
+            pieces[BLACK] == rhs.pieces[BLACK] &&
+            kings == rhs.kings &&
+            taken == rhs.taken &&
+            chain == rhs.chain &&
+            turn == rhs.turn;
+}
+
+std::ostream& operator<<(std::ostream &os, const Engine10 &e)
+{
+    constexpr auto SIDE_STR = "wb-";
+    constexpr auto FILE_STR = "abcdefghij";
+
+    os << "\nGAME BOARD:\n\n";
+
+    for (int r = 9; r >= 0; --r) {
+        os << (r + 1) << (r == 9 ? "  " : "   ");
+        for (int f = 0; f <= 9; ++f) {
+
+            char c = ' ';
+
+            if ((r + f) % 2 == 0) {
+
+                const auto sq = square10(r, f);
+                c = '.';
+
+                if (get(e.pieces[WHITE], sq))
+                    c = 'w';
+                else if (get(e.pieces[BLACK], sq))
+                    c = 'b';
+
+                if (get(e.kings, sq))
+                    c = toupper(c);
+            }
+            os << c << ' ';
+        }
+        os << '\n';
+    }
+    os << "\n   ";
+    for (int f = 0; f <= 9; ++f)
+        os << ' ' << FILE_STR[f];
+    os	<< "\n\nside:\t" << SIDE_STR[e.turn];
+
+    return os;
+}
@@ -104,16 +104,9 @@ void Game::graphic_move()
     }
 
     if (active_move.type & CAPTURE) {
-
-        Square trg_sq = 64;
-
-        switch (to - from) {
-            case NORTH_EAST * 2: trg_sq = from + NORTH_EAST; break;
-            case NORTH_WEST * 2: trg_sq = from + NORTH_WEST; break;
-            case SOUTH_EAST * 2: trg_sq = to + NORTH_WEST; break;
-            case SOUTH_WEST * 2: trg_sq = to + NORTH_EAST; break;
-        }
-        if (valid(trg_sq) && pieces[trg_sq]) {
+        for (const auto trg_sq : BitIterator(between(from, to))) {
+            if (!pieces[trg_sq])
+                continue;
 #if LEAVE_CORPSES == true
             pieces[trg_sq]->type = DEAD;
             pieces[trg_sq]->setOpacity(0.4);
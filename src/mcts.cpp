@@ -0,0 +1,271 @@
+#include "mcts.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <thread>
+#include <vector>
+
+namespace {
+
+constexpr double EXPLORATION    = 1.4;
+constexpr size_t PLAYOUT_PLIES  = 150;
+constexpr int DRAW_MARGIN       = 100;      // Unfinished playout is won by side ahead more than this
+constexpr size_t MIN_NODES      = 256;      // Root and more than any move count
+
+uint64_t random(uint64_t &s)
+{
+    s ^= s << 13;
+    s ^= s >> 7;
+    s ^= s << 17;
+    return s;
+}
+
+uint32_t points(Color winner, Color mover)
+{
+    return winner == BOTH ? 1 : winner == mover ? 2 : 0;
+}
+
+bool same(Move a, Move b)
+{
+    return a.from == b.from && a.to == b.to && a.type == b.type;
+}
+
+} // namespace
+
+uint32_t Mcts::Arena::alloc(size_t n)
+{
+    const auto i = top.fetch_add(n, std::memory_order_relaxed);
+    return i + n <= capacity ? uint32_t(i) : NONE;
+}
+
+Mcts::Mcts(size_t max_nodes, size_t threads_) :
+    arena(std::make_unique<Arena>(std::max(max_nodes, MIN_NODES))),
+    spare(std::make_unique<Arena>(std::max(max_nodes, MIN_NODES))),
+    threads(std::max<size_t>(threads_, 1))
+{
+    last.node_bytes = sizeof(Node);
+
+    Engine e;
+    e.reset();
+    reset(e);
+}
+
+void Mcts::init(Node &n, Move move, Color mover)
+{
+    n.move = move;
+    n.mover = mover;
+    n.state.store(LEAF, std::memory_order_relaxed);
+    n.count = 0;
+    n.first = NONE;
+    n.visits.store(0, std::memory_order_relaxed);
+    n.score.store(0, std::memory_order_relaxed);
+    n.virtual_loss.store(0, std::memory_order_relaxed);
+}
+
+void Mcts::reset(const Engine &e)
+{
+    root_pos = e;
+    arena->top = 1;
+    init(node(0), Move{}, ~e.turn);
+    expand(node(0), root_pos);
+}
+
+Move Mcts::search(uint64_t playouts)
+{
+    std::atomic<int64_t> budget{int64_t(playouts)};
+
+    const auto start = std::chrono::steady_clock::now();
+
+    std::vector<std::thread> workers;
+    for (size_t i = 1; i < threads; ++i)
+        workers.emplace_back(&Mcts::work, this, std::ref(budget), 0x9E3779B97F4A7C15ULL * (i + 1));
+    work(budget, 0x9E3779B97F4A7C15ULL);
+    for (auto &w : workers)
+        w.join();
+
+    const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+    last.playouts   = playouts;
+    last.seconds    = elapsed.count();
+    last.nodes      = std::min(arena->top.load(), arena->capacity);
+
+    const auto &root = node(0);
+    Move best{};
+    uint32_t best_visits = 0;
+
+    for (uint32_t i = root.first; i < root.first + root.count; ++i) {
+        if (node(i).visits > best_visits) {
+            best_visits = node(i).visits;
+            best = node(i).move;
+        }
+    }
+    if (!best_visits) {
+        const auto moves = root_pos.legal_moves();
+        if (!moves.empty())
+            best = moves.front();
+    }
+    return best;
+}
+
+bool Mcts::advance(Move move)
+{
+    const auto moves = root_pos.legal_moves();
+    if (std::none_of(moves.begin(), moves.end(), [&](Move m) { return same(m, move); }))
+        return false;
+
+    auto next = root_pos;
+    next.act(move);
+
+    const auto &root = node(0);
+    uint32_t child = NONE;
+
+    if (root.state == EXPANDED)
+        for (uint32_t i = root.first; i < root.first + root.count; ++i)
+            if (same(node(i).move, move))
+                child = i;
+
+    if (child == NONE) {
+        reset(next);
+        last.nodes = arena->top;
+        return true;
+    }
+
+    // Breadth first copy into spare arena, so children stay in contiguous blocks
+    std::vector<std::pair<uint32_t, uint32_t>> queue = { { child, 0 } };
+    spare->top = 1;
+
+    for (size_t q = 0; q < queue.size(); ++q) {
+
+        const auto [from, to] = queue[q];
+        const auto &src = node(from);
+        auto &dst = spare->nodes[to];
+
+        init(dst, src.move, src.mover);
+        dst.visits.store(src.visits);
+        dst.score.store(src.score);
+
+        if (src.state != EXPANDED)
+            continue;
+
+        const auto first = src.count ? spare->alloc(src.count) : NONE;
+
+        for (uint32_t i = 0; i < src.count; ++i)
+            queue.push_back({ src.first + i, first + i });
+
+        dst.first = first;
+        dst.count = src.count;
+        dst.state = EXPANDED;
+    }
+
+    std::swap(arena, spare);
+    root_pos = next;
+
+    // New root was a leaf, so arena holds only the root
+    expand(node(0), root_pos);
+    last.nodes = arena->top;
+
+    return true;
+}
+
+void Mcts::work(std::atomic<int64_t> &budget, uint64_t rng)
+{
+    std::vector<uint32_t> path;
+
+    while (budget.fetch_sub(1, std::memory_order_relaxed) > 0) {
+
+        Engine e = root_pos;
+        uint32_t i = 0;
+
+        path.assign(1, 0);
+        ++node(0).virtual_loss;
+
+        while (node(i).state.load(std::memory_order_acquire) == EXPANDED && node(i).count) {
+            i = select(node(i), rng);
+            e.act(node(i).move);
+            ++node(i).virtual_loss;
+            path.push_back(i);
+        }
+
+        // Node is expanded on second visit, playout starts from one of its children
+        auto &leaf = node(i);
+        if ((leaf.visits || !i) && expand(leaf, e)) {
+            i = leaf.first + random(rng) % leaf.count;
+            e.act(node(i).move);
+            ++node(i).virtual_loss;
+            path.push_back(i);
+        }
+
+        const auto winner = playout(e, rng);
+
+        for (const auto j : path) {
+            auto &n = node(j);
+            n.score.fetch_add(points(winner, n.mover), std::memory_order_relaxed);
+            n.visits.fetch_add(1, std::memory_order_relaxed);
+            n.virtual_loss.fetch_sub(1, std::memory_order_relaxed);
+        }
+    }
+}
+
+// UCT, virtual losses count as visits which scored nothing
+uint32_t Mcts::select(const Node &parent, uint64_t &rng) const
+{
+    const double log_n = std::log(double(parent.visits + parent.virtual_loss) + 1);
+    const uint32_t offset = random(rng) % parent.count;
+
+    uint32_t best = parent.first;
+    double best_v = -1;
+
+    for (uint32_t k = 0; k < parent.count; ++k) {
+
+        const uint32_t i = parent.first + (k + offset) % parent.count;
+        const auto &c = node(i);
+        const auto n = c.visits.load(std::memory_order_relaxed) + c.virtual_loss.load(std::memory_order_relaxed);
+
+        if (!n)
+            return i;
+
+        const double v = c.score.load(std::memory_order_relaxed) / (2.0 * n) + EXPLORATION * std::sqrt(log_n / n);
+        if (v > best_v) {
+            best_v = v;
+            best = i;
+        }
+    }
+    return best;
+}
+
+bool Mcts::expand(Node &n, const Engine &e)
+{
+    uint8_t expected = LEAF;
+    if (!n.state.compare_exchange_strong(expected, EXPANDING, std::memory_order_acq_rel))
+        return false;
+
+    const auto moves = e.legal_moves();
+    const auto first = moves.empty() ? NONE : arena->alloc(moves.size());
+
+    // Arena is full, node stays leaf
+    if (!moves.empty() && first == NONE) {
+        n.state.store(LEAF, std::memory_order_release);
+        return false;
+    }
+    for (size_t k = 0; k < moves.size(); ++k)
+        init(node(first + k), moves[k], e.turn);
+
+    n.first = first;
+    n.count = uint16_t(moves.size());
+    n.state.store(EXPANDED, std::memory_order_release);
+
+    return n.count;
+}
+
+Color Mcts::playout(Engine e, uint64_t &rng) const
+{
+    for (size_t ply = 0; ply < PLAYOUT_PLIES; ++ply) {
+        const auto moves = e.legal_moves();
+        if (moves.empty())
+            return ~e.turn;
+        e.act(moves[random(rng) % moves.size()]);
+    }
+    const auto eval = e.evaluate();
+
+    return eval > DRAW_MARGIN ? e.turn : eval < -DRAW_MARGIN ? ~e.turn : BOTH;
+}
@@ -0,0 +1,134 @@
+#include "profile.h"
+
+#ifdef ENGINE_PROFILE
+
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <vector>
+
+namespace profile {
+namespace {
+
+// Blocks outlive their threads so counts of finished threads are kept,
+// blocks released by finished threads are handed to new ones.
+struct Registry {
+    std::mutex mutex;
+    std::vector<std::unique_ptr<Block>> blocks;
+    std::vector<Block*> released;
+};
+
+Registry& registry()
+{
+    static Registry r;
+    return r;
+}
+
+double ratio(uint64_t a, uint64_t b)
+{
+    return b ? double(a) / b : 0;
+}
+
+} // namespace
+
+Handle::Handle()
+{
+    auto &r = registry();
+    std::lock_guard lock(r.mutex);
+
+    if (r.released.empty()) {
+        r.blocks.push_back(std::make_unique<Block>());
+        block = r.blocks.back().get();
+    } else {
+        block = r.released.back();
+        r.released.pop_back();
+    }
+}
+
+Handle::~Handle()
+{
+    auto &r = registry();
+    std::lock_guard lock(r.mutex);
+    r.released.push_back(block);
+}
+
+const char* name(Probe p)
+{
+    constexpr const char *NAMES[PROBE_NUM] = {
+        "legal_moves",
+        "captures",
+        "man_capture_moves",
+        "king_capture_moves",
+        "act",
+    };
+    return NAMES[p];
+}
+
+Report collect()
+{
+    auto &r = registry();
+    std::lock_guard lock(r.mutex);
+
+    Report report = {};
+    for (const auto &b : r.blocks) {
+        for (size_t p = 0; p < PROBE_NUM; ++p) {
+            report[p].calls  += (*b)[p].calls.load(std::memory_order_relaxed);
+            report[p].items  += (*b)[p].items.load(std::memory_order_relaxed);
+            report[p].cycles += (*b)[p].cycles.load(std::memory_order_relaxed);
+        }
+    }
+    return report;
+}
+
+// Owners bump with plain load and store, a reset racing with them may be lost
+void reset()
+{
+    auto &r = registry();
+    std::lock_guard lock(r.mutex);
+
+    for (const auto &b : r.blocks) {
+        for (auto &slot : *b) {
+            slot.calls.store(0, std::memory_order_relaxed);
+            slot.items.store(0, std::memory_order_relaxed);
+            slot.cycles.store(0, std::memory_order_relaxed);
+        }
+    }
+}
+
+void dump_json(std::ostream &os)
+{
+    const auto report = collect();
+
+    os << "{\n  \"cycles\": " << (TIMED ? "true" : "false") << ",\n  \"probes\": {\n";
+    for (size_t p = 0; p < PROBE_NUM; ++p) {
+        const auto &c = report[p];
+        os << "    \"" << name(Probe(p)) << "\": {"
+           << " \"calls\": " << c.calls
+           << ", \"items\": " << c.items
+           << ", \"items_per_call\": " << ratio(c.items, c.calls)
+           << ", \"cycles\": " << c.cycles
+           << ", \"cycles_per_call\": " << ratio(c.cycles, c.calls)
+           << " }" << (p + 1 < PROBE_NUM ? ",\n" : "\n");
+    }
+    os << "  }\n}\n";
+}
+
+void dump_csv(std::ostream &os)
+{
+    const auto report = collect();
+
+    os << "probe,calls,items,items_per_call,cycles,cycles_per_call\n";
+    for (size_t p = 0; p < PROBE_NUM; ++p) {
+        const auto &c = report[p];
+        os << name(Probe(p)) << ','
+           << c.calls << ','
+           << c.items << ','
+           << ratio(c.items, c.calls) << ','
+           << c.cycles << ','
+           << ratio(c.cycles, c.calls) << '\n';
+    }
+}
+
+} // profile
+
+#endif // ENGINE_PROFILE
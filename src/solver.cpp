@@ -0,0 +1,403 @@
+#include "solver.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <thread>
+
+namespace {
+
+constexpr uint32_t INF          = 0x7FFFFFFF;
+constexpr uint32_t VIRTUAL      = 4;        // Added per thread searching a node
+constexpr size_t MAX_DEPTH      = 1000;
+constexpr size_t MAX_LINE       = 1000;
+constexpr size_t WAYS           = 4;        // Entries per cluster
+
+// Sums of unsolved numbers saturate below INF, which only solved nodes reach.
+// Transpositions count twice, so they grow fast and root would stop at its threshold.
+constexpr uint32_t add(uint32_t a, uint32_t b)
+{
+    return a >= INF || b >= INF ? INF : uint32_t(std::min<uint64_t>(uint64_t(a) + b, INF - 1));
+}
+
+struct Entry {
+    uint64_t key    = 0;                    // Zero if empty
+    uint32_t pn     = 1;
+    uint32_t dn     = 1;
+    uint32_t work   = 0;                    // Nodes searched under entry, saturated
+    uint16_t busy   = 0;                    // Threads searching it now
+    uint16_t dist   = 0;                    // Plies to end of proof or disproof, if solved
+
+    bool solved() const { return !pn || !dn; }
+};
+
+struct Cluster {
+    std::atomic_flag lock = ATOMIC_FLAG_INIT;
+    Entry entries[WAYS];
+};
+
+struct Lock {
+    Lock(Cluster &c_) : c(c_)   { while (c.lock.test_and_set(std::memory_order_acquire)); }
+    ~Lock()                     { c.lock.clear(std::memory_order_release); }
+    Cluster &c;
+};
+
+constexpr int width(uint32_t x) { int w = 0; for (; x; x >>= 1) ++w; return w; }
+
+struct Table {
+
+    Table(size_t bytes) : size(std::max<size_t>(1, bytes / sizeof(Cluster))), clusters(new Cluster[size]) {}
+
+    Entry get(uint64_t key)
+    {
+        auto &c = cluster(key);
+        Lock lock(c);
+        for (const auto &e : c.entries)
+            if (e.key == key)
+                return e;
+        return {};
+    }
+
+    void put(uint64_t key, uint32_t pn, uint32_t dn, uint64_t work, uint32_t dist = 0)
+    {
+        update(key, [&](Entry &e) {
+            // Proofs don't depend on path, stale results of other threads can't undo them
+            // and distance only shrinks, so it stays below distance of any parent
+            if (!e.pn) {
+                if (!pn)
+                    e.dist = uint16_t(std::min<uint32_t>(e.dist, dist));
+                return;
+            }
+            e.pn    = pn;
+            e.dn    = dn;
+            e.work  = uint32_t(std::min<uint64_t>(work, INF));
+            e.dist  = uint16_t(std::min<uint32_t>(dist, UINT16_MAX));
+        });
+    }
+
+    // Busy count doesn't evict live entries, it's kept only where there's room
+    void enter(uint64_t key)    { update(key, [](Entry &e) { ++e.busy; }, false); }
+    void leave(uint64_t key)    { find(key, [](Entry &e) { e.busy -= e.busy > 0; }); }
+
+    size_t peak() const         { return max_used * sizeof(Entry); }
+
+private:
+    Cluster& cluster(uint64_t key) { return clusters[key % size]; }
+
+    static uint64_t priority(const Entry &e)
+    {
+        return !e.key ? 0 : e.work + (e.solved() ? uint64_t(INF) : 0);
+    }
+
+    template <class F>
+    void find(uint64_t key, F f)
+    {
+        auto &c = cluster(key);
+        Lock lock(c);
+        for (auto &e : c.entries) {
+            if (e.key == key) {
+                f(e);
+                return;
+            }
+        }
+    }
+
+    // Entry for key is created in place of least valuable one, unless all are busy,
+    // or only in empty one if evict is false
+    template <class F>
+    void update(uint64_t key, F f, bool evict = true)
+    {
+        {
+            auto &c = cluster(key);
+            Lock lock(c);
+
+            Entry *victim = nullptr;
+            for (auto &e : c.entries) {
+                if (e.key == key) {
+                    f(e);
+                    return;
+                }
+                if (!e.busy && (evict || !e.key) && (!victim || priority(e) < priority(*victim)))
+                    victim = &e;
+            }
+            if (!victim)
+                return;
+            if (!victim->key) {
+                const auto n = ++used;
+                auto peak = max_used.load();
+                while (n > peak && !max_used.compare_exchange_weak(peak, n));
+            }
+            *victim = {};
+            victim->key = key;
+            f(*victim);
+        }
+        if (used > size * WAYS * 9 / 10)
+            collect();
+    }
+
+    // Frees entries with least work, unsolved ones first, until table is 60% full
+    void collect()
+    {
+        if (collecting.test_and_set())
+            return;
+
+        uint64_t hist[2][33] = {};
+
+        for (size_t i = 0; i < size; ++i) {
+            Lock lock(clusters[i]);
+            for (const auto &e : clusters[i].entries)
+                if (e.key && !e.busy)
+                    ++hist[e.solved()][width(e.work)];
+        }
+
+        uint64_t target = used - std::min<size_t>(used, size * WAYS * 6 / 10);
+        int bound[2] = { -1, -1 };
+
+        for (int s = 0; s < 2 && target; ++s) {
+            for (int b = 0; b < 33 && target; ++b) {
+                target -= std::min(target, hist[s][b]);
+                bound[s] = b;
+            }
+        }
+
+        for (size_t i = 0; i < size; ++i) {
+            Lock lock(clusters[i]);
+            for (auto &e : clusters[i].entries) {
+                if (e.key && !e.busy && width(e.work) <= bound[e.solved()]) {
+                    e = {};
+                    --used;
+                }
+            }
+        }
+        collecting.clear();
+    }
+
+    const size_t size;
+    std::unique_ptr<Cluster[]> clusters;
+    std::atomic<size_t> used{0};
+    std::atomic<size_t> max_used{0};
+    std::atomic_flag collecting = ATOMIC_FLAG_INIT;
+};
+
+struct Search {
+
+    Search(Table &table_, Color attacker_, uint64_t budget_) : table(table_), attacker(attacker_), budget(budget_) {}
+
+    void run(const Engine &root)
+    {
+        const auto key = root.hash() | 1;
+        std::vector<uint64_t> path;
+
+        while (!stopped()) {
+            mid(root, key, INF, INF, path);
+            const auto x = table.get(key);
+            if (x.solved()) {
+                proven = !x.pn;
+                stop = true;
+            }
+        }
+    }
+
+    // Kept apart from table, where stale results of other threads may overwrite disproof
+    bool solved() const { return stop; }
+    bool won() const    { return proven; }
+
+
+    // Attacker takes shortest win, defender longest, distance strictly decreases
+    MoveList line(Engine e)
+    {
+        MoveList line;
+        uint32_t left = table.get(e.hash() | 1).dist;
+
+        while (left && line.size() < MAX_LINE) {
+
+            const bool or_node = e.turn == attacker;
+            bool found = false;
+            Move best;
+            uint32_t best_dist = 0;
+
+            for (const auto &m : e.legal_moves()) {
+                auto c = e;
+                c.act(m);
+                const auto x = table.get(c.hash() | 1);
+                if (!x.key || x.pn || x.dist >= left)
+                    continue;
+                if (!found || (or_node ? x.dist < best_dist : x.dist > best_dist)) {
+                    found = true;
+                    best = m;
+                    best_dist = x.dist;
+                }
+            }
+            if (!found)
+                break;
+            line.push_back(best);
+            e.act(best);
+            left = best_dist;
+        }
+        return line;
+    }
+
+    std::atomic<uint64_t> nodes{0};
+private:
+    struct Child {
+        Engine e;
+        uint64_t key;
+    };
+
+    bool stopped() const { return stop || nodes >= budget; }
+
+    uint64_t mid(const Engine &e, uint64_t key, uint32_t tpn, uint32_t tdn, std::vector<uint64_t> &path)
+    {
+        ++nodes;
+
+        const bool or_node = e.turn == attacker;
+        const auto moves = e.legal_moves();
+
+        // Side to move without moves loses
+        if (moves.empty()) {
+            table.put(key, or_node ? INF : 0, or_node ? 0 : INF, 1);
+            return 1;
+        }
+        // Too deep is treated like repetition, unproven for attacker
+        if (path.size() >= MAX_DEPTH) {
+            table.put(key, INF, 0, 1);
+            return 1;
+        }
+
+        std::vector<Child> children;
+        children.reserve(moves.size());
+        for (const auto &m : moves) {
+            children.push_back({ e, 0 });
+            children.back().e.act(m);
+            children.back().key = children.back().e.hash() | 1;
+        }
+
+        path.push_back(key);
+
+        uint64_t work = 1;
+
+        while (true) {
+
+            uint32_t pn = or_node ? INF : 0;
+            uint32_t dn = or_node ? 0 : INF;
+            uint32_t best_v = INF, second_v = INF;
+            uint32_t min_pd = INF, max_pd = 0;      // Distances of proven children
+            uint32_t min_dd = INF, max_dd = 0;      // And of disproven ones
+            Entry best_x;
+            size_t best = 0;
+
+            for (size_t i = 0; i < children.size(); ++i) {
+
+                Entry x;
+                if (std::find(path.begin(), path.end(), children[i].key) != path.end()) {
+                    x.pn = INF;
+                    x.dn = 0;
+                } else {
+                    x = table.get(children[i].key);
+                }
+
+                if (!x.pn) {
+                    min_pd = std::min<uint32_t>(min_pd, x.dist + 1);
+                    max_pd = std::max<uint32_t>(max_pd, x.dist + 1);
+                }
+                if (!x.dn) {
+                    min_dd = std::min<uint32_t>(min_dd, x.dist + 1);
+                    max_dd = std::max<uint32_t>(max_dd, x.dist + 1);
+                }
+
+                const auto v = add(or_node ? x.pn : x.dn, x.busy * VIRTUAL);
+
+                if (or_node) {
+                    pn = std::min(pn, x.pn);
+                    dn = add(dn, x.dn);
+                } else {
+                    pn = add(pn, x.pn);
+                    dn = std::min(dn, x.dn);
+                }
+                if (v < best_v) {
+                    second_v = best_v;
+                    best_v = v;
+                    best_x = x;
+                    best = i;
+                } else if (v < second_v) {
+                    second_v = v;
+                }
+            }
+
+            // Winner of solved node picks shortest way, loser longest
+            const auto dist = !pn ? (or_node ? min_pd : max_pd) : !dn ? (or_node ? max_dd : min_dd) : 0;
+
+            table.put(key, pn, dn, work, dist);
+
+            if (pn >= tpn || dn >= tdn || !pn || !dn || stopped())
+                break;
+
+            // 1 + epsilon trick, child runs a bit longer than till it stops being best
+            const auto limit = add(second_v + second_v / 4, 1);
+            uint32_t cpn, cdn;
+
+            // Child picked past busy siblings gets at least one more than it has, or it
+            // returns at once and thread spins here until others are done
+            if (or_node) {
+                cpn = std::max(std::min(tpn, limit), best_x.pn + 1);
+                cdn = tdn >= INF ? INF : add(tdn - dn, best_x.dn);
+            } else {
+                cdn = std::max(std::min(tdn, limit), best_x.dn + 1);
+                cpn = tpn >= INF ? INF : add(tpn - pn, best_x.pn);
+            }
+
+            const auto &c = children[best];
+            table.enter(c.key);
+            work += mid(c.e, c.key, cpn, cdn, path);
+            table.leave(c.key);
+        }
+
+        path.pop_back();
+
+        return work;
+    }
+
+    Table &table;
+    const Color attacker;
+    const uint64_t budget;
+    std::atomic<bool> stop{false};
+    std::atomic<bool> proven{false};
+};
+
+} // namespace
+
+Solution solve(const Engine &e, uint64_t nodes, size_t memory, size_t threads)
+{
+    Solution s;
+
+    // Win of side to move first, then its loss with what's left of budget
+    for (const auto attacker : { e.turn, ~e.turn }) {
+
+        Table table(memory);
+        Search search(table, attacker, nodes - s.nodes);
+
+        const auto start = std::chrono::steady_clock::now();
+
+        std::vector<std::thread> workers;
+        for (size_t i = 1; i < threads; ++i)
+            workers.emplace_back([&] { search.run(e); });
+        search.run(e);
+        for (auto &w : workers)
+            w.join();
+
+        const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+        s.seconds += elapsed.count();
+        s.nodes += search.nodes;
+        s.peak_memory = std::max(s.peak_memory, table.peak());
+
+        if (search.won()) {
+            s.result = attacker == e.turn ? PROVEN_WIN : PROVEN_LOSS;
+            s.line = search.line(e);
+            break;
+        }
+        if (!search.solved() || s.nodes >= nodes)
+            break;
+    }
+    return s;
+}
@@ -0,0 +1,128 @@
+// Microbenchmarks of bit primitives, every available path of count, lsb, pext,
+// shift and BitIterator plus engine move generation built on top of them.
+
+#include "engine.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+static std::vector<Bitboard> boards;
+static uint64_t sink = 0;
+
+constexpr int REPEATS = 9;
+
+// Untimed warm-up pass, then best and median of timed repeats
+template <class F>
+static void run(const char *name, F f, int rounds = 50)
+{
+    double times[REPEATS];
+
+    for (int rep = -1; rep < REPEATS; ++rep) {
+
+        const auto start = std::chrono::steady_clock::now();
+
+        uint64_t acc = 0;
+        for (int r = 0; r < rounds; ++r)
+            for (const auto bb : boards)
+                acc += f(bb);
+        sink += acc;
+
+        const std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+
+        if (rep >= 0)
+            times[rep] = elapsed.count() / (double(rounds) * boards.size());
+    }
+    std::sort(times, times + REPEATS);
+
+    std::printf("%-28s %8.3f ns/op best %8.3f ns/op median\n", name, times[0], times[REPEATS / 2]);
+}
+
+template <int (*Lsb)(uint64_t)>
+static uint64_t iterate(Bitboard bb)
+{
+    uint64_t acc = 0;
+    for (; bb; bb &= bb - 1)
+        acc += Lsb(bb);
+    return acc;
+}
+
+static uint64_t iterate_ops(Bitboard bb)
+{
+    uint64_t acc = 0;
+    for (; bb; bb &= bb - 1)
+        acc += bits::OPS.lsb(bb);
+    return acc;
+}
+
+static uint64_t iterate_misc(Bitboard bb)
+{
+    uint64_t acc = 0;
+    for (const auto sq : BitIterator(bb))
+        acc += sq;
+    return acc;
+}
+
+static int lsb_misc(uint64_t bb)    { return lsb(bb); }
+static int count_misc(uint64_t bb)  { return count(bb); }
+
+int main()
+{
+    std::mt19937_64 rng(1);
+
+    // Sparse boards like piece sets in a game, up to 12 bits out of 32 dark squares
+    boards.resize(1 << 16);
+    for (auto &bb : boards) {
+        bb = 0;
+        for (int n = rng() % 12 + 1; n; --n)
+            bb |= bitboard(Square(rng() % 64)) & DARK_SQUARES;
+        bb |= 1;
+    }
+
+    std::printf("cpu: popcnt %d, bmi %d, bmi2 %d\n\n", bits::CPU.popcnt, bits::CPU.bmi, bits::CPU.bmi2);
+
+    run("count portable",           bits::count_sw);
+    run("count misc.h",             count_misc);
+    run("count runtime",            [](Bitboard bb) { return bits::OPS.count(bb); });
+#ifdef BITS_X86
+    if (bits::CPU.popcnt)
+        run("count popcnt",         bits::count_hw);
+#endif
+
+    run("lsb portable",             bits::lsb_sw);
+    run("lsb misc.h",               lsb_misc);
+    run("lsb runtime",              [](Bitboard bb) { return bits::OPS.lsb(bb); });
+#ifdef BITS_X86
+    if (bits::CPU.bmi)
+        run("lsb tzcnt",            bits::lsb_hw);
+#endif
+
+    run("pext portable",            [](Bitboard bb) { return bits::pext_sw(bb, DARK_SQUARES); });
+    run("pext runtime",             [](Bitboard bb) { return bits::OPS.pext(bb, DARK_SQUARES); });
+#ifdef BITS_X86
+    if (bits::CPU.bmi2)
+        run("pext bmi2",            [](Bitboard bb) { return bits::pext_hw(bb, DARK_SQUARES); });
+#endif
+
+    run("shift north east",         [](Bitboard bb) { return shift(bb, NORTH_EAST); });
+    run("shift south west",         [](Bitboard bb) { return shift(bb, SOUTH_WEST); });
+    run("shift both diagonals",     [](Bitboard bb) { return shift(bb, std::array{NORTH_EAST, NORTH_WEST}); });
+
+    run("BitIterator misc.h",       iterate_misc);
+    run("BitIterator portable",     iterate<bits::lsb_sw>);
+    run("BitIterator runtime",      iterate_ops);
+#ifdef BITS_X86
+    if (bits::CPU.bmi)
+        run("BitIterator tzcnt",    iterate<bits::lsb_hw>);
+#endif
+
+    Engine e;
+    e.reset();
+    run("Engine::legal_moves",      [&e](Bitboard) { return e.legal_moves().size(); }, 5);
+    run("Engine::board",            [&e](Bitboard) { return e.board().size(); }, 5);
+
+    std::printf("\n(%llu)\n", (unsigned long long) sink);
+
+    return 0;
+}
@@ -0,0 +1,71 @@
+// Plays given position with Monte Carlo tree search, reusing tree between moves.
+
+#include "mcts.h"
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <thread>
+
+int main(int argc, char *argv[])
+{
+    std::string fen;
+    uint64_t playouts = 100'000;
+    size_t nodes = 4'000'000;
+    size_t moves = 1;
+    size_t threads = std::max(1u, std::thread::hardware_concurrency());
+    Rules rules = ENGLISH;
+    bool ok = true;
+
+    for (int i = 1; i < argc && ok; ++i) {
+
+        const std::string arg = argv[i];
+        const bool has_val = i + 1 < argc;
+
+        if (arg == "--playouts" && has_val)
+            playouts = std::strtoull(argv[++i], nullptr, 10);
+        else if (arg == "--nodes" && has_val)
+            nodes = std::strtoull(argv[++i], nullptr, 10);
+        else if (arg == "--moves" && has_val)
+            moves = std::strtoull(argv[++i], nullptr, 10);
+        else if (arg == "--threads" && has_val)
+            threads = std::max(1, std::atoi(argv[++i]));
+        else if (arg == "--rules" && has_val)
+            ok = rules_from(argv[++i], rules);
+        else if (arg[0] != '-' && fen.empty())
+            fen = arg;
+        else
+            ok = false;
+    }
+
+    Engine e;
+    e.reset(rules);
+
+    if (!ok || (!fen.empty() && !e.load(fen))) {
+        std::cerr << "usage: mcts [fen] [--playouts N] [--nodes N] [--moves N] [--threads N] "
+                     "[--rules english|russian|brazilian|pool]\n";
+        return 1;
+    }
+
+    Mcts mcts(nodes, threads);
+    mcts.reset(e);
+
+    std::cout << "node:\t" << mcts.stats().node_bytes << " bytes\n";
+
+    for (size_t i = 0; i < moves && !mcts.position().legal_moves().empty(); ++i) {
+
+        const auto m = mcts.search(playouts);
+        const auto s = mcts.stats();
+
+        if (!mcts.advance(m)) {
+            std::cerr << "mcts: search returned illegal move\n";
+            return 1;
+        }
+
+        std::cout << pdn_number(m.from) << (m.type & CAPTURE ? 'x' : '-') << pdn_number(m.to)
+                  << '\t' << uint64_t(s.playouts / std::max(s.seconds, 1e-9)) << " playouts/s"
+                  << '\t' << s.nodes << " nodes, " << s.nodes * s.node_bytes / 1024 << " KiB"
+                  << '\t' << mcts.stats().nodes << " kept\n";
+    }
+    return 0;
+}
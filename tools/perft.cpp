@@ -0,0 +1,142 @@
+// Perft, number of leaf nodes of the full move tree from initial position.
+// Capture chains played hop by hop are joined into whole moves, and whole moves
+// with the same result (same piece, landing square and captured pieces, taken in
+// different order) are counted once, like in published reference counts.
+// Built with ENGINE_PROFILE, --profile json|csv writes hot path counters to stderr.
+
+#include "engine.h"
+#include "engine10.h"
+#include "profile.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <vector>
+
+template <class E>
+static void expand(const E &e, std::vector<E> &out)
+{
+    for (const auto m : e.legal_moves()) {
+
+        E next = e;
+        next.act(m);
+
+        if (next.turn == e.turn)
+            expand(next, out);
+        else if (!(m.type & CAPTURE) || std::find(out.begin(), out.end(), next) == out.end())
+            out.push_back(next);
+    }
+}
+
+template <class E>
+static uint64_t perft(const E &e, int depth)
+{
+    std::vector<E> moves;
+    expand(e, moves);
+
+    if (depth <= 1)
+        return moves.size();
+
+    uint64_t nodes = 0;
+    for (const auto &next : moves)
+        nodes += perft(next, depth - 1);
+
+    return nodes;
+}
+
+struct Variant {
+    const char *name;
+    bool (*run)(const Variant &v, int depth);
+    Rules rules;
+    std::vector<uint64_t> reference;
+};
+
+static void init(Engine &e, const Variant &v)   { e.reset(v.rules); }
+static void init(Engine10 &e, const Variant &)  { e.reset(); }
+
+template <class E>
+static bool run(const Variant &v, int depth)
+{
+    E e;
+    init(e, v);
+
+    bool ok = true;
+
+    for (int d = 1; d <= depth; ++d) {
+
+        const auto start = std::chrono::steady_clock::now();
+        const auto nodes = perft(e, d);
+        const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+        std::printf("%-14s %2d %14llu %10.3f s %12.0f nodes/s", v.name, d, (unsigned long long) nodes,
+            elapsed.count(), nodes / std::max(elapsed.count(), 1e-9));
+
+        if (size_t(d) <= v.reference.size()) {
+            const bool match = nodes == v.reference[d - 1];
+            std::printf(match ? "  ok\n" : "  FAIL, expected %llu\n", (unsigned long long) v.reference[d - 1]);
+            ok &= match;
+        } else {
+            std::printf("\n");
+        }
+    }
+    return ok;
+}
+
+static const Variant VARIANTS[] = {
+    { "english",        run<Engine>,    ENGLISH,    { 7, 49, 302, 1469, 7361, 36768, 179740, 845931, 3963680, 18391564 } },
+    { "russian",        run<Engine>,    RUSSIAN,    { 7, 49, 302, 1469, 7482, 37986, 190146, 929899, 4570586, 22444032 } },
+    { "brazilian",      run<Engine>,    BRAZILIAN,  { 7, 49, 302, 1469, 7473, 37628, 187302, 907830, 4431766, 21560022 } },
+    { "pool",           run<Engine>,    POOL,       { 7, 49, 302, 1469, 7482, 37986, 190146, 929896, 4570534, 22435955 } },
+    { "international",  run<Engine10>,  {},         { 9, 81, 658, 4265, 27117, 167140, 1049442, 6483961, 41022423, 258895763 } },
+};
+
+int main(int argc, char *argv[])
+{
+    const char *name = nullptr;
+    const char *profile = nullptr;
+    int depth = 0;
+    bool args_ok = true;
+
+    for (int i = 1; i < argc; ++i) {
+        if (!std::strcmp(argv[i], "--profile") && i + 1 < argc)
+            profile = argv[++i];
+        else if (!name)
+            name = argv[i];
+        else if (!depth)
+            depth = std::atoi(argv[i]);
+        else
+            args_ok = false;
+    }
+    if (profile && std::strcmp(profile, "json") && std::strcmp(profile, "csv"))
+        args_ok = false;
+#ifndef ENGINE_PROFILE
+    if (profile) {
+        std::fprintf(stderr, "perft: --profile needs build with ENGINE_PROFILE\n");
+        return 1;
+    }
+#endif
+
+    bool ok = true;
+    bool found = false;
+
+    for (const auto &v : VARIANTS) {
+        if (!args_ok || (name && std::strcmp(name, v.name) && std::strcmp(name, "all")))
+            continue;
+        found = true;
+        ok &= v.run(v, depth ? depth : 8);
+    }
+
+    if (!found) {
+        std::fprintf(stderr, "usage: perft [all|english|russian|brazilian|pool|international] [depth] [--profile json|csv]\n");
+        return 1;
+    }
+#ifdef ENGINE_PROFILE
+    if (profile && !std::strcmp(profile, "json"))
+        profile::dump_json(std::cerr);
+    else if (profile)
+        profile::dump_csv(std::cerr);
+#endif
+    return ok ? 0 : 1;
+}
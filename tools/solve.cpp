@@ -0,0 +1,119 @@
+// Proves win or loss of side to move in given position.
+
+#include "solver.h"
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <thread>
+
+struct Known {
+    const char *rules;
+    const char *fen;
+    Proof result;
+};
+
+// Positions with known result, proof line must end where loser has no moves
+const Known KNOWN[] = {
+    { "english",    "W:WK14,K15:BK23",  PROVEN_WIN },
+    { "english",    "B:WK14,K15:BK23",  PROVEN_LOSS },
+    { "english",    "W:W22,23:B14",     PROVEN_WIN },
+    { "russian",    "W:WK32:B14,19",    PROVEN_WIN },
+    { "brazilian",  "B:WK1,K5:BK32",    PROVEN_LOSS },
+};
+
+// Only positions of given rules, all if empty
+static bool check(const std::string &only, uint64_t nodes, size_t memory, size_t threads)
+{
+    bool ok = true;
+
+    for (const auto &k : KNOWN) {
+
+        if (!only.empty() && only != k.rules)
+            continue;
+
+        Rules rules;
+        rules_from(k.rules, rules);
+
+        Engine e;
+        e.reset(rules);
+        e.load(k.fen);
+
+        const auto s = solve(e, nodes, memory, threads);
+        const auto winner = k.result == PROVEN_WIN ? e.turn : ~e.turn;
+
+        for (const auto &m : s.line)
+            e.act(m);
+
+        const bool match = s.result == k.result && e.legal_moves().empty() && e.turn == ~winner;
+
+        std::cout << k.rules << '\t' << k.fen << '\t' << s.line.size() << " plies" << (match ? "\tok\n" : "\tFAIL\n");
+        ok &= match;
+    }
+    return ok;
+}
+
+int main(int argc, char *argv[])
+{
+    std::string fen;
+    uint64_t nodes = 10'000'000;
+    size_t memory = 256;
+    size_t threads = std::max(1u, std::thread::hardware_concurrency());
+    Rules rules = ENGLISH;
+    std::string rules_name;
+    bool known = false;
+    bool ok = true;
+
+    for (int i = 1; i < argc && ok; ++i) {
+
+        const std::string arg = argv[i];
+        const bool has_val = i + 1 < argc;
+
+        if (arg == "--nodes" && has_val)
+            nodes = std::strtoull(argv[++i], nullptr, 10);
+        else if (arg == "--memory" && has_val)
+            memory = std::strtoull(argv[++i], nullptr, 10);
+        else if (arg == "--threads" && has_val)
+            threads = std::max(1, std::atoi(argv[++i]));
+        else if (arg == "--rules" && has_val) {
+            rules_name = argv[++i];
+            ok = rules_from(rules_name, rules);
+        }
+        else if (arg == "--check")
+            known = true;
+        else if (arg[0] != '-' && fen.empty())
+            fen = arg;
+        else
+            ok = false;
+    }
+
+    if (ok && known)
+        return check(rules_name, nodes, memory << 20, threads) ? 0 : 1;
+
+    Engine e;
+    e.reset(rules);
+
+    if (!ok || fen.empty() || !e.load(fen)) {
+        std::cerr << "usage: solve <fen>|--check [--nodes N] [--memory MB] [--threads N] "
+                     "[--rules english|russian|brazilian|pool]\n";
+        return 1;
+    }
+
+    const auto s = solve(e, nodes, memory << 20, threads);
+
+    constexpr const char *RESULT_STR[] = { "unknown", "win", "loss" };
+
+    std::cout << "result:\t" << RESULT_STR[s.result] << '\n';
+
+    if (s.result != UNPROVEN) {
+        std::cout << "line:\t";
+        for (const auto &m : s.line)
+            std::cout << pdn_number(m.from) << (m.type & CAPTURE ? 'x' : '-') << pdn_number(m.to) << ' ';
+        std::cout << '\n';
+    }
+    std::cout << "nodes:\t" << s.nodes << '\n'
+              << "speed:\t" << uint64_t(s.nodes / std::max(s.seconds, 1e-9)) << " nodes/s\n"
+              << "table:\t" << s.peak_memory / 1024 << " KiB peak\n";
+
+    return 0;
+}
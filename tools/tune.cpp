@@ -0,0 +1,351 @@
+// Offline evaluation tuner.
+//
+// Dataset is a text file with one labelled position per line: "<fen> <result>", where
+// fen is in Engine::load() format and result is from white's point of view, either as
+// number (1, 0.5, 0) or PDN game result (1-0, 1/2-1/2, 0-1). File is streamed in
+// batches, each batch is one Adam step of logistic loss over sigmoid(k * eval).
+// One reader only does I/O, persistent workers parse and accumulate their slices.
+
+#include "engine.h"
+#include "weights.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <cstdlib>
+#include <fstream>
+#include <future>
+#include <iomanip>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+struct Sample {
+    Features features;
+    float result;
+};
+
+using Lines = std::vector<std::string>;
+
+// Gradient and loss summed by one worker over its share of batch
+struct Partial {
+    std::vector<double> grad = std::vector<double>(EVAL_NUM);
+    double loss         = 0;
+    size_t positions    = 0;
+    size_t bad          = 0;
+};
+
+struct Options {
+    std::string data;
+    std::string out     = "weights.h";
+    size_t threads      = std::max(1u, std::thread::hardware_concurrency());
+    size_t batch        = 1 << 16;
+    int epochs          = 10;
+    double rate         = 1.0;
+    double k            = 0.01;
+};
+
+static bool parse_result(const char *str, float &result)
+{
+    const std::string_view s(str);
+
+    if (s == "1-0" || s == "2-0")
+        result = 1;
+    else if (s == "0-1" || s == "0-2")
+        result = 0;
+    else if (s == "1/2-1/2" || s == "1-1")
+        result = 0.5;
+    else {
+        char *end;
+        result = std::strtof(str, &end);
+        if (end == str || *end || result < 0 || result > 1)
+            return false;
+    }
+    return true;
+}
+
+// Result is cut off in place
+static bool parse_sample(std::string &line, Engine &e, Sample &s)
+{
+    const auto sep = line.find_first_of(" \t");
+    const auto res = line.find_first_not_of(" \t\r", sep);
+    if (res == std::string::npos)
+        return false;
+
+    const auto end = line.find_first_of(" \t\r", res);
+    if (end != std::string::npos)
+        line[end] = 0;
+
+    if (!e.load(line.substr(0, sep)) || !parse_result(line.c_str() + res, s.result))
+        return false;
+
+    s.features = e.features();
+    return true;
+}
+
+static Lines read_lines(std::istream &in, size_t size)
+{
+    Lines lines(size);
+    size_t n = 0;
+
+    while (n < size && std::getline(in, lines[n]))
+        ++n;
+    lines.resize(n);
+    return lines;
+}
+
+static void accumulate(const Sample &s, const std::vector<double> &w, double k, Partial &part)
+{
+    double eval = 0;
+    for (size_t i = 0; i < EVAL_NUM; ++i)
+        eval += s.features[i] * w[i];
+
+    const double p = 1 / (1 + std::exp(-k * eval));
+    const double err = k * (p - s.result);
+
+    for (size_t i = 0; i < EVAL_NUM; ++i)
+        if (s.features[i])
+            part.grad[i] += err * s.features[i];
+
+    part.loss -= s.result * std::log(std::max(p, 1e-12)) + (1 - s.result) * std::log(std::max(1 - p, 1e-12));
+    ++part.positions;
+}
+
+// Persistent workers, each parses its slice of batch lines and accumulates own gradient
+struct Pool {
+
+    Pool(size_t n, double k_) : parts(n), k(k_)
+    {
+        for (size_t t = 0; t < n; ++t)
+            workers.emplace_back(&Pool::work, this, t);
+    }
+
+    ~Pool()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            quit = true;
+        }
+        start.notify_all();
+        for (auto &w : workers)
+            w.join();
+    }
+
+    // Returns when all workers are done with batch
+    void run(Lines &batch, const std::vector<double> &weights)
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            lines = &batch;
+            w = &weights;
+            finished = 0;
+            ++generation;
+        }
+        start.notify_all();
+
+        std::unique_lock<std::mutex> lock(mutex);
+        done.wait(lock, [&] { return finished == parts.size(); });
+    }
+
+    std::vector<Partial> parts;
+private:
+    void work(size_t t)
+    {
+        uint64_t seen = 0;
+        Engine e;
+        Sample s;
+
+        while (true) {
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                start.wait(lock, [&] { return quit || generation != seen; });
+                if (quit)
+                    return;
+                seen = generation;
+            }
+
+            auto &part = parts[t] = {};
+            const size_t chunk = (lines->size() + parts.size() - 1) / parts.size();
+            const size_t end = std::min(lines->size(), (t + 1) * chunk);
+
+            for (size_t i = t * chunk; i < end; ++i) {
+                auto &line = (*lines)[i];
+                if (parse_sample(line, e, s))
+                    accumulate(s, *w, k, part);
+                else if (!line.empty())
+                    ++part.bad;
+            }
+
+            std::lock_guard<std::mutex> lock(mutex);
+            if (++finished == parts.size())
+                done.notify_one();
+        }
+    }
+
+    const double k;
+    std::vector<std::thread> workers;
+    std::mutex mutex;
+    std::condition_variable start, done;
+    Lines *lines = nullptr;
+    const std::vector<double> *w = nullptr;
+    uint64_t generation = 0;
+    size_t finished = 0;
+    bool quit = false;
+};
+
+struct Adam {
+
+    void step(std::vector<double> &w, const std::vector<double> &grad, double rate)
+    {
+        ++t;
+        for (size_t i = 0; i < w.size(); ++i) {
+            m[i] = B1 * m[i] + (1 - B1) * grad[i];
+            v[i] = B2 * v[i] + (1 - B2) * grad[i] * grad[i];
+            const double mh = m[i] / (1 - std::pow(B1, t));
+            const double vh = v[i] / (1 - std::pow(B2, t));
+            w[i] -= rate * mh / (std::sqrt(vh) + 1e-8);
+        }
+    }
+private:
+    static constexpr double B1 = 0.9;
+    static constexpr double B2 = 0.999;
+
+    std::vector<double> m = std::vector<double>(EVAL_NUM);
+    std::vector<double> v = std::vector<double>(EVAL_NUM);
+    int t = 0;
+};
+
+static bool write_header(const std::string &path, const std::vector<double> &w)
+{
+    std::ofstream out(path);
+
+    out << "#ifndef WEIGHTS_H\n"
+           "#define WEIGHTS_H\n\n"
+           "#include \"eval.h\"\n\n"
+           "// Generated by tools/tune, do not edit by hand\n\n"
+           "constexpr Weights WEIGHTS = {\n    ";
+
+    out << std::lround(w[EVAL_MAN]) << ", " << std::lround(w[EVAL_KING]) << ",\n";
+
+    for (size_t i = 0; i < 32; ++i)
+        out << (i % 4 ? " " : "    ") << std::setw(3) << std::lround(w[EVAL_PSQT + i]) << (i % 4 == 3 ? ",\n" : ",");
+
+    out << "};\n\n"
+           "#endif // WEIGHTS_H\n";
+
+    return bool(out);
+}
+
+static bool parse_args(int argc, char *argv[], Options &opt)
+{
+    for (int i = 1; i < argc; ++i) {
+
+        const std::string arg = argv[i];
+        const bool has_val = i + 1 < argc;
+
+        if (arg == "--out" && has_val)
+            opt.out = argv[++i];
+        else if (arg == "--threads" && has_val)
+            opt.threads = std::max(1, std::atoi(argv[++i]));
+        else if (arg == "--batch" && has_val)
+            opt.batch = std::max(1, std::atoi(argv[++i]));
+        else if (arg == "--epochs" && has_val)
+            opt.epochs = std::atoi(argv[++i]);
+        else if (arg == "--rate" && has_val)
+            opt.rate = std::atof(argv[++i]);
+        else if (arg == "--k" && has_val)
+            opt.k = std::atof(argv[++i]);
+        else if (arg[0] != '-' && opt.data.empty())
+            opt.data = arg;
+        else
+            return false;
+    }
+    return !opt.data.empty();
+}
+
+int main(int argc, char *argv[])
+{
+    Options opt;
+
+    if (!parse_args(argc, argv, opt)) {
+        std::cerr << "usage: tune <dataset> [--out weights.h] [--threads N] [--batch N] "
+                     "[--epochs N] [--rate X] [--k X]\n";
+        return 1;
+    }
+
+    std::vector<double> w(WEIGHTS.begin(), WEIGHTS.end());
+    w[EVAL_PSQT_REF] = 0;                   // Pinned, its feature is always zero
+    Adam adam;
+    Pool pool(opt.threads, opt.k);
+
+    for (int epoch = 1; epoch <= opt.epochs; ++epoch) {
+
+        std::ifstream in(opt.data);
+        if (!in) {
+            std::cerr << "tune: can't open " << opt.data << '\n';
+            return 1;
+        }
+
+        const auto start = std::chrono::steady_clock::now();
+
+        size_t positions = 0;
+        size_t bad = 0;
+        double loss = 0;
+
+        // Next batch is read while workers parse and process current one
+        auto next = std::async(std::launch::async, read_lines, std::ref(in), opt.batch);
+
+        while (true) {
+
+            auto batch = next.get();
+            if (batch.empty())
+                break;
+            next = std::async(std::launch::async, read_lines, std::ref(in), opt.batch);
+
+            pool.run(batch, w);
+
+            std::vector<double> grad(EVAL_NUM);
+            size_t n = 0;
+
+            for (const auto &part : pool.parts) {
+                for (size_t i = 0; i < EVAL_NUM; ++i)
+                    grad[i] += part.grad[i];
+                loss += part.loss;
+                n += part.positions;
+                bad += part.bad;
+            }
+            if (!n)
+                continue;
+            for (auto &g : grad)
+                g /= n;
+
+            adam.step(w, grad, opt.rate);
+            positions += n;
+        }
+
+        const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+        std::cout << "epoch " << epoch
+                  << ": " << positions << " positions"
+                  << ", loss " << (positions ? loss / positions : 0)
+                  << ", " << elapsed.count() << " s"
+                  << ", " << size_t(positions / elapsed.count()) << " pos/s";
+        if (bad)
+            std::cout << ", " << bad << " bad lines";
+        std::cout << std::endl;
+
+        if (!positions)
+            return 1;
+    }
+
+    if (!write_header(opt.out, w)) {
+        std::cerr << "tune: can't write " << opt.out << '\n';
+        return 1;
+    }
+    std::cout << "weights written to " << opt.out << std::endl;
+
+    return 0;
+}